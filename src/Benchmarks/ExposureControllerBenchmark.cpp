@@ -0,0 +1,123 @@
+/*!
+ * \file ExposureControllerBenchmark.cpp
+ * \brief Cost and convergence time of host-side auto exposure on simulated camera.
+ *
+ * Usage: ExposureControllerBenchmark [width] [height] [settle_frames] [step]
+ *
+ * Synthetic scene (gradient with small saturated lamp) is rendered with simulated
+ * exposure and gain response: pixel value is proportional to scene radiance,
+ * illumination, exposure time and linear gain, clipped at 255. New settings
+ * requested by controller reach the sensor after settle_frames frames, frames
+ * in between are exposed with previous settings and are not metered, as in
+ * CameraGigE. For every illumination step number of frames needed to converge
+ * is reported, average metering and control cost per metered frame is printed at the end.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <opencv2/opencv.hpp>
+
+#include "ExposureController.hpp"
+
+namespace {
+
+/// Exposure in seconds giving mean brightness about 64 at illumination 1 and no gain
+const double REFERENCE_EXPOSURE = 0.01;
+
+/// Frames after which step is reported as not converged
+const int MAX_FRAMES = 1000;
+
+void createScene(cv::Mat & scene, int width, int height) {
+	scene.create(height, width, CV_32FC1);
+
+	for (int y = 0; y < height; ++y) {
+		float * row = scene.ptr<float>(y);
+		for (int x = 0; x < width; ++x)
+			row[x] = 0.2f + 0.3f * x / width * (0.5f + 0.5f * std::sin(y * 0.05f));
+	}
+
+	// lamp covering 0.25% of frame, always saturated
+	cv::Rect lamp(width / 2, height / 4, width / 20, height / 20);
+	scene(lamp).setTo(cv::Scalar(20.0));
+}
+
+void render(const cv::Mat & scene, double illumination, const Types::CameraSettings & settings, cv::Mat & img) {
+	double scale = 128.0 * illumination * settings.exposure / REFERENCE_EXPOSURE * std::pow(10.0, settings.gain / 20.0);
+	scene.convertTo(img, CV_8U, scale);
+}
+
+}
+
+int main(int argc, char * argv[]) {
+	int width = (argc > 1) ? atoi(argv[1]) : 1280;
+	int height = (argc > 2) ? atoi(argv[2]) : 960;
+	int settle_frames = (argc > 3) ? atoi(argv[3]) : 1;
+	int step = (argc > 4) ? atoi(argv[4]) : 4;
+
+	cv::Mat scene, img;
+	createScene(scene, width, height);
+
+	Sources::CameraGigE::ExposureController controller;
+	controller.setTarget(128, 0.01);
+	controller.setWindow(cv::Rect(), step);
+	controller.setDamping(0.7, 0.05);
+	controller.setExposureRange(0.00001, 0.1);
+	controller.setGainRange(0, 24);
+
+	// settings exposing current frame, settings requested by controller
+	Types::CameraSettings applied, pending;
+	applied.exposure = REFERENCE_EXPOSURE;
+	int delay = 0;
+
+	const double illuminations[] = { 1.0, 4.0, 0.25, 0.05, 1.0, 10.0 };
+	const int steps = sizeof(illuminations) / sizeof(illuminations[0]);
+
+	printf("frame %dx%d, metering step %d, settle frames %d\n", width, height, step, settle_frames);
+
+	for (int i = 0; i < steps; ++i) {
+		double illumination = illuminations[i];
+		bool disturbed = false;
+		int frames;
+
+		for (frames = 0; frames < MAX_FRAMES; ++frames) {
+			bool settled = (delay == 0);
+
+			render(scene, illumination, applied, img);
+
+			if (!settled && --delay == 0)
+				applied = pending;
+
+			controller.countFrame();
+			if (!settled)
+				continue;
+
+			Types::CameraSettings next;
+			if (controller.update(img, applied, next)) {
+				pending = next;
+				if (settle_frames > 0)
+					delay = settle_frames;
+				else
+					applied = next;
+			}
+
+			if (!controller.converged())
+				disturbed = true;
+			else
+				break;
+		}
+
+		printf("illumination %6.2f : ", illumination);
+		if (frames == MAX_FRAMES)
+			printf("not converged in %d frames", MAX_FRAMES);
+		else
+			printf("converged in %4lu frames", disturbed ? controller.convergenceFrames() : 0UL);
+		printf(", exposure %8.3f ms, gain %2d dB, brightness %6.1f, saturated %5.2f%%\n",
+				applied.exposure * 1000.0, applied.gain, controller.brightness(), controller.saturation() * 100.0);
+	}
+
+	printf("metering and control cost %.1f us/metered frame\n", controller.averageCost() * 1000000.0);
+
+	return 0;
+}
@@ -0,0 +1,152 @@
+/*!
+ * \file SharedFrameRingBenchmark.cpp
+ * \brief Throughput of shared memory frame ring with one writer and several readers.
+ *
+ * Usage: SharedFrameRingBenchmark [readers] [frames] [width] [height] [slots] [fps]
+ *
+ * Writer publishes frames of given size (BGR) at given rate (0 - as fast as
+ * possible, default), every reader
+ * thread reads through its own SharedFrameReader. Frame rate and data rate of
+ * writer and every reader are reported together with number of lost frames and
+ * number of frames with inconsistent content (which should always be 0).
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "Types/SharedFrameRing.hpp"
+
+namespace {
+
+const char * RING_NAME = "/CameraGigE_benchmark";
+
+volatile bool writer_done = false;
+
+double now() {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+struct ReaderResult {
+	pthread_t thread;
+	bool attached;
+	unsigned long frames;
+	unsigned long corrupted;
+	unsigned long long lost;
+	unsigned long long bytes;
+	double time;
+};
+
+void * reader(void * arg) {
+	ReaderResult * result = (ReaderResult *) arg;
+
+	Types::SharedFrameReader reader;
+	result->attached = reader.attach(RING_NAME);
+	if (!result->attached)
+		return NULL;
+
+	Types::SharedFrame frame;
+	double start = 0, end = 0;
+
+	for (;;) {
+		Types::SharedFrameReader::Status status = reader.read(frame);
+
+		if (status == Types::SharedFrameReader::Ok || status == Types::SharedFrameReader::Overrun) {
+			end = now();
+			if (result->frames == 0)
+				start = end;
+			++result->frames;
+			result->bytes += frame.data.size();
+
+			// writer fills every frame with its low byte of frame counter
+			unsigned char expected = (unsigned char) frame.info.frameCount;
+			if (frame.data.empty() || frame.data[0] != expected || frame.data[frame.data.size() - 1] != expected)
+				++result->corrupted;
+		} else if (status == Types::SharedFrameReader::Closed) {
+			break;
+		} else if (writer_done) {
+			break;
+		} else {
+			sched_yield();
+		}
+	}
+
+	result->time = end - start;
+	result->lost = reader.lost();
+
+	return NULL;
+}
+
+}
+
+int main(int argc, char * argv[]) {
+	int readers = (argc > 1) ? atoi(argv[1]) : 3;
+	unsigned long frames = (argc > 2) ? atol(argv[2]) : 5000;
+	unsigned int width = (argc > 3) ? atoi(argv[3]) : 640;
+	unsigned int height = (argc > 4) ? atoi(argv[4]) : 480;
+	unsigned int slots = (argc > 5) ? atoi(argv[5]) : 4;
+	double fps = (argc > 6) ? atof(argv[6]) : 0;
+
+	unsigned int step = width * 3;
+	unsigned int size = step * height;
+
+	Types::SharedFrameWriter writer;
+	if (!writer.create(RING_NAME, slots, size)) {
+		perror("Unable to create shared memory");
+		return 1;
+	}
+
+	std::vector<ReaderResult> results(readers);
+	for (int i = 0; i < readers; ++i) {
+		memset(&results[i], 0, sizeof(ReaderResult));
+		pthread_create(&results[i].thread, NULL, reader, &results[i]);
+	}
+
+	// let readers attach before first frame
+	usleep(100000);
+
+	std::vector<unsigned char> image(size);
+	Types::FrameInfo info;
+
+	double start = now();
+	for (unsigned long i = 0; i < frames; ++i) {
+		info.frameCount = i;
+		memset(&image[0], (unsigned char) i, size);
+		writer.publish(&image[0], width, height, 16 /* CV_8UC3 */, step, info);
+
+		if (fps > 0) {
+			double wait = start + (i + 1) / fps - now();
+			if (wait > 0)
+				usleep(wait * 1000000.0);
+		}
+	}
+	double time = now() - start;
+
+	writer_done = true;
+	for (int i = 0; i < readers; ++i)
+		pthread_join(results[i].thread, NULL);
+
+	writer.destroy();
+
+	printf("frame %ux%u BGR, %u slots, %lu frames\n", width, height, slots, frames);
+	printf("writer   : %10.1f frames/s %10.1f MB/s\n", frames / time, frames * (double) size / time / 1000000.0);
+	for (int i = 0; i < readers; ++i) {
+		const ReaderResult & r = results[i];
+		if (!r.attached || r.time <= 0) {
+			printf("reader %d : %s\n", i, r.attached ? "no frames read" : "unable to attach");
+			continue;
+		}
+		printf("reader %d : %10.1f frames/s %10.1f MB/s, read %lu, lost %llu, corrupted %lu\n", i,
+				r.frames / r.time, r.bytes / r.time / 1000000.0, r.frames, r.lost, r.corrupted);
+	}
+
+	return 0;
+}
@@ -7,6 +7,12 @@
 
 #include <boost/bind.hpp>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
 #include "Utils.hpp"
 
 namespace Sources {
@@ -17,7 +23,50 @@ CameraGigE::CameraGigE(const std::string & name) :
 	m_device_address("device.address", std::string("")),
 	m_acquisition_mode("acquisition.mode", boost::bind(&CameraGigE::onAcquisitionModeChanged, this, _1, _2), std::string("Continuous")),
 	m_exposure_mode("image.exposure.mode", std::string("")),
-	m_exposure_value ("image.exposure.value", boost::bind(&CameraGigE::onExposureValueChanged, this, _1, _2), -1){
+	m_exposure_value ("image.exposure.value", boost::bind(&CameraGigE::onExposureValueChanged, this, _1, _2), -1),
+	m_gain_mode("image.gain.mode", std::string("")),
+	m_gain_value("image.gain.value", boost::bind(&CameraGigE::onGainValueChanged, this, _1, _2), 0),
+	m_whitebal_mode("image.whitebalance.mode", std::string("")),
+	m_whitebal_red("image.whitebalance.red", boost::bind(&CameraGigE::onWhitebalRedChanged, this, _1, _2), 50),
+	m_whitebal_blue("image.whitebalance.blue", boost::bind(&CameraGigE::onWhitebalBlueChanged, this, _1, _2), 50),
+	m_settle_frames("acquisition.settle_frames", 1),
+	m_regions("regions", std::string("")),
+	m_regions_copy("regions.copy", false),
+	m_regions_auto_roi("regions.auto_roi", true),
+	m_accumulate_mode("accumulate.mode", std::string("None")),
+	m_accumulate_frames("accumulate.frames", 4),
+	m_hdr_exposures("accumulate.hdr.exposures", std::string("")),
+	m_hdr_key("accumulate.hdr.key", 1.0),
+	m_gating_enabled("gating.enabled", false),
+	m_gating_threshold("gating.threshold", 4.0),
+	m_gating_step("gating.step", 8),
+	m_gating_tiles("gating.tiles", 8),
+	m_gating_keyframe("gating.keyframe", 30),
+	m_shm_name("shm.name", std::string("")),
+	m_shm_slots("shm.slots", 4),
+	m_stats_histogram("statistics.histogram", false),
+	m_stats_mean("statistics.mean", false),
+	m_stats_clipped("statistics.clipped", false),
+	m_stats_focus("statistics.focus", false),
+	m_ae_enabled("autoexposure.enabled", false),
+	m_ae_target("autoexposure.target", 128.0),
+	m_ae_saturation("autoexposure.saturation", 0.01),
+	m_ae_damping("autoexposure.damping", 0.7),
+	m_ae_tolerance("autoexposure.tolerance", 0.05),
+	m_ae_step("autoexposure.step", 4),
+	m_ae_window_x("autoexposure.window.x", 0),
+	m_ae_window_y("autoexposure.window.y", 0),
+	m_ae_window_width("autoexposure.window.width", 0),
+	m_ae_window_height("autoexposure.window.height", 0),
+	settings_generation(0),
+	unsettled_frames(0),
+	rejected_exposure(-1),
+	camera_exposure_auto(false),
+	camera_gain_auto(false),
+	camera_whitebal_auto(false),
+	frame_period(0),
+	hdr_idx(0),
+	accumulate_generation(0) {
 	LOG(LTRACE) << "Hello CameraGigE from dl\n";
 
 	if (PvInitialize() == ePvErrResources) {
@@ -28,11 +77,48 @@ CameraGigE::CameraGigE(const std::string & name) :
 	registerProperty(m_exposure_mode);
 	registerProperty(m_exposure_value);
 	registerProperty(m_acquisition_mode);
+	registerProperty(m_gain_mode);
+	registerProperty(m_gain_value);
+	registerProperty(m_whitebal_mode);
+	registerProperty(m_whitebal_red);
+	registerProperty(m_whitebal_blue);
+	registerProperty(m_settle_frames);
+	registerProperty(m_regions);
+	registerProperty(m_regions_copy);
+	registerProperty(m_regions_auto_roi);
+	registerProperty(m_accumulate_mode);
+	registerProperty(m_accumulate_frames);
+	registerProperty(m_hdr_exposures);
+	registerProperty(m_hdr_key);
+	registerProperty(m_gating_enabled);
+	registerProperty(m_gating_threshold);
+	registerProperty(m_gating_step);
+	registerProperty(m_gating_tiles);
+	registerProperty(m_gating_keyframe);
+	registerProperty(m_shm_name);
+	registerProperty(m_shm_slots);
+	registerProperty(m_stats_histogram);
+	registerProperty(m_stats_mean);
+	registerProperty(m_stats_clipped);
+	registerProperty(m_stats_focus);
+	registerProperty(m_ae_enabled);
+	registerProperty(m_ae_target);
+	registerProperty(m_ae_saturation);
+	registerProperty(m_ae_damping);
+	registerProperty(m_ae_tolerance);
+	registerProperty(m_ae_step);
+	registerProperty(m_ae_window_x);
+	registerProperty(m_ae_window_y);
+	registerProperty(m_ae_window_width);
+	registerProperty(m_ae_window_height);
 }
 
 CameraGigE::~CameraGigE() {
 	LOG(LTRACE) << "Goodbye CameraGigE from dl\n";
 
+	for (size_t i = 0; i < regions.size(); ++i)
+		delete regions[i].stream;
+
 	PvUnInitialize();
 }
 
@@ -43,6 +129,17 @@ void CameraGigE::prepareInterface() {
 	addDependency("onTrigger", &in_trigger);
 
 	registerStream("out_img", &out_img);
+	registerStream("out_info", &out_info);
+	registerStream("out_stats", &out_stats);
+
+	if (!parseRegions(m_regions)) {
+		CLOG(LWARNING) << "Invalid regions \"" << m_regions << "\", expected name:x,y,width,height;... with unique names"
+				<< " other than img, info and stats and non-negative coordinates";
+	}
+	for (size_t i = 0; i < regions.size(); ++i) {
+		regions[i].stream = new Base::DataStreamOut<cv::Mat>;
+		registerStream("out_" + regions[i].name, regions[i].stream);
+	}
 
 	h_onGrabFrame.setup(this, &CameraGigE::onGrabFrame);
 	registerHandler("onGrabFrame", &h_onGrabFrame);
@@ -109,66 +206,101 @@ bool CameraGigE::onInit() {
 			CLOG(LWARNING) << "Unable to set ExposureMode \n";
 		}
 	}
-/*
+
 	/// Gain
-	if (!props.gainMode.empty()) {
-		if ((err = PvAttrEnumSet(cHandle, "GainMode", props.gainMode.c_str()))
-				== ePvErrSuccess) {
-			if (props.gainMode == "Manual") {
-				if ((err = PvAttrUint32Set(cHandle, "gainValue",
-						props.gainValue)) != ePvErrSuccess) {
-					if (err == ePvErrOutOfRange) {
-						tPvUint32 min, max;
-						PvAttrRangeUint32(cHandle, "GainValue", &min, &max);
-						LOG(LWARNING) << "GainValue : " << props.gainValue
-								<< " is out of range, valid range [ "
-								<< (double) min << " , " << (double) max
-								<< " ]\n";
-					}
-				}
+	if (m_gain_mode != "") {
+		if ((err = PvAttrEnumSet(cHandle, "GainMode", std::string(m_gain_mode).c_str())) == ePvErrSuccess) {
+			if (m_gain_mode == "Manual") {
+				setAttrUint32("GainValue", m_gain_value);
 			}
 		} else {
-			LOG(LWARNING) << "Unable to set GainMode \n";
+			CLOG(LWARNING) << "Unable to set GainMode \n";
 		}
 	}
+
 	///	White Balance
-	if (!props.whitebalMode.empty()) {
-		if ((err = PvAttrEnumSet(cHandle, "WhitebalMode",
-				props.gainMode.c_str())) == ePvErrSuccess) {
-			if (props.whitebalMode == "Manual") {
-				if ((err = PvAttrUint32Set(cHandle, "WhitebalValueRed",
-						props.whitebalValueRed)) != ePvErrSuccess) {
-					if (err == ePvErrOutOfRange) {
-						tPvUint32 min, max;
-						PvAttrRangeUint32(cHandle, "WhitebalValueRed", &min,
-								&max);
-						LOG(LWARNING) << "WhitebalValueRed : "
-								<< props.whitebalValueRed
-								<< " is out of range, valid range [ "
-								<< (double) min << " , " << (double) max
-								<< " ]\n";
-					}
-				}
+	if (m_whitebal_mode != "") {
+		if ((err = PvAttrEnumSet(cHandle, "WhitebalMode", std::string(m_whitebal_mode).c_str())) == ePvErrSuccess) {
+			if (m_whitebal_mode == "Manual") {
+				setAttrUint32("WhitebalValueRed", m_whitebal_red);
+				setAttrUint32("WhitebalValueBlue", m_whitebal_blue);
+			}
+		} else {
+			CLOG(LWARNING) << "Unable to set WhitebalMode [" << getErrorMsg(err) << "]\n";
+		}
+	}
 
-				if ((err = PvAttrUint32Set(cHandle, "WhitebalValueBlue",
-						props.whitebalValueBlue)) != ePvErrSuccess) {
-					if (err == ePvErrOutOfRange) {
-						tPvUint32 min, max;
-						PvAttrRangeUint32(cHandle, "WhitebalValueBlue", &min,
-								&max);
-						LOG(LWARNING) << "WhitebalValueBlue : "
-								<< props.whitebalValueBlue
-								<< " is out of range, valid range [ "
-								<< (double) min << " , " << (double) max
-								<< " ]\n";
-					}
-				}
+	/// Host-side auto exposure
+	if (m_ae_enabled) {
+		if ((err = PvAttrEnumSet(cHandle, "ExposureMode", "Manual")) != ePvErrSuccess) {
+			CLOG(LWARNING) << "Unable to set ExposureMode for auto exposure [" << getErrorMsg(err) << "]";
+		}
+		if ((err = PvAttrEnumSet(cHandle, "GainMode", "Manual")) != ePvErrSuccess) {
+			CLOG(LWARNING) << "Unable to set GainMode for auto exposure [" << getErrorMsg(err) << "]";
+		}
+
+		tPvUint32 min, max;
+		if (PvAttrRangeUint32(cHandle, "ExposureValue", &min, &max) == ePvErrSuccess)
+			exposure_controller.setExposureRange(min / 1000000.0, max / 1000000.0);
+		if (PvAttrRangeUint32(cHandle, "GainValue", &min, &max) == ePvErrSuccess)
+			exposure_controller.setGainRange(min, max);
+	}
+
+	/// HDR bracketing
+	hdr_exposures.clear();
+	hdr_idx = 0;
+	if (m_accumulate_mode == "HDR") {
+		std::stringstream ss(m_hdr_exposures);
+		std::string item;
+		tPvUint32 min = 0, max = 0;
+		PvAttrRangeUint32(cHandle, "ExposureValue", &min, &max);
+
+		while (std::getline(ss, item, ',')) {
+			double exposure = atof(item.c_str());
+			if (exposure <= 0)
+				continue;
+			if (max > 0 && (exposure * 1000000.0 < min || exposure * 1000000.0 > max)) {
+				CLOG(LWARNING) << "HDR exposure " << exposure << " is out of range, valid range [ "
+						<< min / 1000000.0 << " , " << max / 1000000.0 << " ], skipped";
+				continue;
 			}
+			hdr_exposures.push_back(exposure);
+		}
+
+		if (hdr_exposures.empty()) {
+			CLOG(LWARNING) << "No valid HDR exposures in \"" << m_hdr_exposures << "\"";
 		} else {
-			LOG(LWARNING) << "Unable to set WhitebalMode" << err << "\n";
+			if ((err = PvAttrEnumSet(cHandle, "ExposureMode", "Manual")) != ePvErrSuccess) {
+				CLOG(LWARNING) << "Unable to set ExposureMode for HDR [" << getErrorMsg(err) << "]";
+			}
+			queueUpdate(ParameterUpdate::Exposure, hdr_exposures[0]);
 		}
 	}
 
+	// Values of settings in Auto/AutoOnce modes are changed by camera itself and have to be read after every frame
+	camera_exposure_auto = !isManual("ExposureMode");
+	camera_gain_auto = !isManual("GainMode");
+	camera_whitebal_auto = !isManual("WhitebalMode");
+
+	tPvFloat32 rate;
+	frame_period = 0;
+	if (PvAttrFloat32Get(cHandle, "FrameRate", &rate) == ePvErrSuccess && rate > 0)
+		frame_period = 1.0 / rate;
+
+	// Read back settings actually used by camera, they are reported with each frame
+	tPvUint32 value;
+	if (PvAttrUint32Get(cHandle, "ExposureValue", &value) == ePvErrSuccess)
+		current_settings.exposure = value / 1000000.0;
+	if (PvAttrUint32Get(cHandle, "GainValue", &value) == ePvErrSuccess)
+		current_settings.gain = value;
+	if (PvAttrUint32Get(cHandle, "WhitebalValueRed", &value) == ePvErrSuccess)
+		current_settings.whitebalRed = value;
+	if (PvAttrUint32Get(cHandle, "WhitebalValueBlue", &value) == ePvErrSuccess)
+		current_settings.whitebalBlue = value;
+	previous_settings = current_settings;
+	info.settings = current_settings;
+
+/*
 	if ((err = PvAttrEnumSet(cHandle, "MirrorX", props.mirrorX ? "On" : "Off"))
 			!= ePvErrSuccess) {
 
@@ -245,6 +377,16 @@ bool CameraGigE::onInit() {
 	}*/
 	// ----------------
 
+	/// Regions
+	roi_offset = cv::Point(0, 0);
+	if (!regions.empty() && m_regions_auto_roi) {
+		setRegionsRoi();
+	}
+	if (PvAttrUint32Get(cHandle, "RegionX", &value) == ePvErrSuccess)
+		roi_offset.x = value;
+	if (PvAttrUint32Get(cHandle, "RegionY", &value) == ePvErrSuccess)
+		roi_offset.y = value;
+
 	PvAttrEnumSet(cHandle, "FrameStartTriggerMode", "Freerun");
 
 	unsigned long frameSize = 0;
@@ -261,11 +403,30 @@ bool CameraGigE::onInit() {
 
 	frame_idx = 0;
 
+	// accumulator buffers are allocated here, so capture loop does not allocate
+	if (m_accumulate_mode != "None") {
+		tPvUint32 width = 0, height = 0;
+		char format[32] = "";
+		PvAttrUint32Get(cHandle, "Width", &width);
+		PvAttrUint32Get(cHandle, "Height", &height);
+		PvAttrEnumGet(cHandle, "PixelFormat", format, sizeof(format), NULL);
+		accumulator.allocate(cv::Size(width, height), (std::string(format) == "Mono8") ? CV_8UC1 : CV_8UC3);
+		accumulator.setKey(m_hdr_key);
+		accumulator.reset();
+	}
+
+	if (m_shm_name != "") {
+		if (!shm_writer.create(m_shm_name, m_shm_slots, frameSize)) {
+			CLOG(LWARNING) << "Unable to create shared memory " << m_shm_name << " [" << strerror(errno) << "]";
+		}
+	}
+
 	return true;
 }
 
 bool CameraGigE::onFinish() {
 	CLOG(LTRACE) << "CameraGigE::finish\n";
+	shm_writer.destroy();
 	PvCameraClose(cHandle);
 	return true;
 }
@@ -276,6 +437,9 @@ void CameraGigE::onGrabFrame() {
 	if ((m_acquisition_mode != "Continuous") && (!trigger)) return;
 
 	trigger = false;
+
+	applyPendingUpdates();
+
 	if (m_acquisition_mode == "SingleFrame")
 		if (ePvErrSuccess != (Err = PvCommandRun(cHandle, "AcquisitionStart"))) {
 			CLOG(LWARNING) << "Frame trigger failed, error " << Err << " [" << getErrorMsg(Err) << "]";
@@ -283,14 +447,69 @@ void CameraGigE::onGrabFrame() {
 
 	Err = PvCaptureQueueFrame(cHandle, &frame[frame_idx], NULL);
 	if (!Err) {
-		Err = PvCaptureWaitForFrameDone(cHandle, &frame[frame_idx], m_exposure_value*1000*5);
+		Err = PvCaptureWaitForFrameDone(cHandle, &frame[frame_idx], frameTimeout());
 		if (!Err) {
 
 			if (frame[frame_idx].Status == ePvErrSuccess) {
 				img = cv::Mat(frame[frame_idx].Height, frame[frame_idx].Width, (frame[frame_idx].Format
 						== ePvFmtMono8) ? CV_8UC1 : CV_8UC3, frame[frame_idx].ImageBuffer);
 
-				out_img.write(img);
+				updateFrameInfo(frame[frame_idx]);
+
+				bool auto_exposure = m_ae_enabled && m_accumulate_mode != "HDR";
+				if (auto_exposure)
+					exposure_controller.countFrame();
+
+				bool publish = true;
+				if (m_accumulate_mode == "Average") {
+					// batch contains only settled frames of single parameter generation
+					if (accumulator.count() > 0 && info.generation != accumulate_generation)
+						accumulator.reset();
+					accumulate_generation = info.generation;
+
+					publish = info.settled && accumulator.average(img, m_accumulate_frames);
+					if (publish)
+						img = accumulator.result();
+				} else if (m_accumulate_mode == "HDR" && !hdr_exposures.empty()) {
+					publish = accumulateBracket();
+					if (publish)
+						img = accumulator.result();
+				}
+
+				// in Average mode exposure is changed only between batches
+				if (auto_exposure && info.settled && (m_accumulate_mode != "Average" || accumulator.count() == 0))
+					updateExposure();
+
+				if (publish && m_gating_enabled) {
+					change_detector.setGrid(m_gating_step, m_gating_tiles);
+					change_detector.setThreshold(m_gating_threshold, m_gating_keyframe);
+					info.suppressed = change_detector.suppressed();
+					publish = change_detector.check(img);
+				}
+
+				if (publish) {
+					// statistics are computed while buffer is still in cache
+					int stats_flags = 0;
+					if (m_stats_histogram) stats_flags |= StatisticsCalculator::Histogram;
+					if (m_stats_mean) stats_flags |= StatisticsCalculator::Mean;
+					if (m_stats_clipped) stats_flags |= StatisticsCalculator::Clipped;
+					if (m_stats_focus) stats_flags |= StatisticsCalculator::Focus;
+					if (stats_flags) {
+						statistics_calculator.compute(img, stats_flags, stats);
+						stats.frameCount = info.frameCount;
+					}
+
+					out_img.write(img);
+					out_info.write(info);
+					if (stats_flags)
+						out_stats.write(stats);
+
+					if (!regions.empty())
+						writeRegions();
+
+					if (shm_writer.isOpen())
+						shm_writer.publish(img.data, img.cols, img.rows, img.type(), img.step, info);
+				}
 			} else {
 				CLOG(LWARNING) << "Grab failed, error " << frame[frame_idx].Status << " [" << getErrorMsg(frame[frame_idx].Status) << "]";
 			}
@@ -318,6 +537,10 @@ bool CameraGigE::onStart() {
 }
 
 bool CameraGigE::onStop() {
+	if (m_gating_enabled) {
+		CLOG(LINFO) << "Change gating suppressed " << change_detector.suppressionRatio() * 100.0 << "% of frames";
+	}
+
 	PvCommandRun(cHandle, "AcquisitionStop");
 	PvCaptureEnd(cHandle);
 	return true;
@@ -329,9 +552,268 @@ void CameraGigE::onTrigger() {
 }
 
 void CameraGigE::onExposureValueChanged(const double & old_exp, const double & new_exp) {
+	queueUpdate(ParameterUpdate::Exposure, new_exp);
+}
+
+void CameraGigE::onGainValueChanged(const int & old_gain, const int & new_gain) {
+	queueUpdate(ParameterUpdate::Gain, new_gain);
+}
+
+void CameraGigE::onWhitebalRedChanged(const int & old_red, const int & new_red) {
+	queueUpdate(ParameterUpdate::WhitebalRed, new_red);
+}
+
+void CameraGigE::onWhitebalBlueChanged(const int & old_blue, const int & new_blue) {
+	queueUpdate(ParameterUpdate::WhitebalBlue, new_blue);
+}
+
+void CameraGigE::queueUpdate(ParameterUpdate::Kind kind, double value) {
+	boost::mutex::scoped_lock lock(updates_mutex);
+	pending_updates.push_back(ParameterUpdate(kind, value));
+}
+
+void CameraGigE::applyPendingUpdates() {
+	std::deque<ParameterUpdate> updates;
+	{
+		boost::mutex::scoped_lock lock(updates_mutex);
+		if (pending_updates.empty())
+			return;
+		updates.swap(pending_updates);
+	}
+
+	bool changed = false;
+
+	for (size_t i = 0; i < updates.size(); ++i) {
+		const ParameterUpdate & u = updates[i];
+		switch (u.kind) {
+		case ParameterUpdate::Exposure:
+			if (setAttrUint32("ExposureValue", u.value * 1000000.0) == ePvErrSuccess) {
+				current_settings.exposure = u.value;
+				changed = true;
+				if (rejected_exposure == u.value)
+					rejected_exposure = -1;
+			} else {
+				rejected_exposure = u.value;
+			}
+			break;
+		case ParameterUpdate::Gain:
+			if (setAttrUint32("GainValue", u.value) == ePvErrSuccess) {
+				current_settings.gain = u.value;
+				changed = true;
+			}
+			break;
+		case ParameterUpdate::WhitebalRed:
+			if (setAttrUint32("WhitebalValueRed", u.value) == ePvErrSuccess) {
+				current_settings.whitebalRed = u.value;
+				changed = true;
+			}
+			break;
+		case ParameterUpdate::WhitebalBlue:
+			if (setAttrUint32("WhitebalValueBlue", u.value) == ePvErrSuccess) {
+				current_settings.whitebalBlue = u.value;
+				changed = true;
+			}
+			break;
+		}
+	}
+
+	// rejected writes did not change anything on camera
+	if (!changed)
+		return;
+
+	// frames delivered so far were exposed with settings reported for the last one
+	previous_settings = info.settings;
+	++settings_generation;
+
+	// in Continuous mode next frames may already be exposed, in triggered modes acquisition starts after this point
+	// counted on host, camera FrameCount wraps at 16 bits
+	unsettled_frames = (m_acquisition_mode == "Continuous") ? (int) m_settle_frames : 0;
+}
+
+tPvErr CameraGigE::setAttrUint32(const char * name, tPvUint32 value) {
 	tPvErr err;
-	if ((err = PvAttrUint32Set(cHandle, "ExposureValue", m_exposure_value * 1000000.0)) != ePvErrSuccess) {
-		CLOG(LWARNING) << "Error while setting new exposure " << new_exp << " [" << getErrorMsg(err) << "]";
+	if ((err = PvAttrUint32Set(cHandle, name, value)) != ePvErrSuccess) {
+		if (err == ePvErrOutOfRange) {
+			tPvUint32 min, max;
+			PvAttrRangeUint32(cHandle, name, &min, &max);
+			CLOG(LWARNING) << name << " : " << value
+					<< " is out of range, valid range [ "
+					<< min << " , " << max << " ]\n";
+		} else {
+			CLOG(LWARNING) << "Error while setting new " << name << " " << value << " [" << getErrorMsg(err) << "]";
+		}
+	}
+	return err;
+}
+
+void CameraGigE::updateFrameInfo(const tPvFrame & f) {
+	info.frameCount = f.FrameCount;
+	info.timestamp = ((unsigned long long) f.TimestampHi << 32) | f.TimestampLo;
+	info.generation = settings_generation;
+	info.settled = (unsettled_frames <= 0);
+	if (!info.settled)
+		--unsettled_frames;
+	info.settings = info.settled ? current_settings : previous_settings;
+
+	// read after frame was captured, so may lag behind camera by one frame
+	tPvUint32 value;
+	if (camera_exposure_auto && PvAttrUint32Get(cHandle, "ExposureValue", &value) == ePvErrSuccess)
+		info.settings.exposure = current_settings.exposure = value / 1000000.0;
+	if (camera_gain_auto && PvAttrUint32Get(cHandle, "GainValue", &value) == ePvErrSuccess)
+		info.settings.gain = current_settings.gain = value;
+	if (camera_whitebal_auto) {
+		if (PvAttrUint32Get(cHandle, "WhitebalValueRed", &value) == ePvErrSuccess)
+			info.settings.whitebalRed = current_settings.whitebalRed = value;
+		if (PvAttrUint32Get(cHandle, "WhitebalValueBlue", &value) == ePvErrSuccess)
+			info.settings.whitebalBlue = current_settings.whitebalBlue = value;
+	}
+}
+
+unsigned long CameraGigE::frameTimeout() {
+	// exposure time is not known in advance when camera controls it
+	if (camera_exposure_auto)
+		return PVINFINITE;
+
+	// exposure may be changed by auto exposure or HDR, frame in flight can still use previous one
+	double exposure = std::max(current_settings.exposure, previous_settings.exposure);
+
+	// waiting for next freerun frame takes up to frame period plus readout
+	double margin = std::max(1.0, 2.0 * frame_period);
+
+	return (exposure + margin) * 1000.0;
+}
+
+bool CameraGigE::isManual(const char * mode_attr) {
+	char mode[32] = "";
+	if (PvAttrEnumGet(cHandle, mode_attr, mode, sizeof(mode), NULL) != ePvErrSuccess)
+		return false;
+	return std::string(mode) == "Manual";
+}
+
+void CameraGigE::updateExposure() {
+	exposure_controller.setTarget(m_ae_target, m_ae_saturation);
+	exposure_controller.setDamping(m_ae_damping, m_ae_tolerance);
+	exposure_controller.setWindow(cv::Rect(m_ae_window_x, m_ae_window_y, m_ae_window_width, m_ae_window_height), m_ae_step);
+
+	bool was_converged = exposure_controller.converged();
+
+	Types::CameraSettings next;
+	if (exposure_controller.update(img, info.settings, next)) {
+		if (next.exposure != info.settings.exposure)
+			queueUpdate(ParameterUpdate::Exposure, next.exposure);
+		if (next.gain != info.settings.gain)
+			queueUpdate(ParameterUpdate::Gain, next.gain);
+	}
+
+	if (exposure_controller.converged() && !was_converged) {
+		CLOG(LINFO) << "Auto exposure converged after " << exposure_controller.convergenceFrames()
+				<< " frames, brightness " << exposure_controller.brightness()
+				<< ", metering cost " << exposure_controller.averageCost() * 1000000.0 << " us/frame";
+	}
+}
+
+bool CameraGigE::accumulateBracket() {
+	bool done = false;
+
+	if (!info.settled)
+		return false;
+
+	// camera refused requested exposure, drop it from bracket instead of requesting it forever
+	if (rejected_exposure == hdr_exposures[hdr_idx]) {
+		rejected_exposure = -1;
+		CLOG(LWARNING) << "HDR exposure " << hdr_exposures[hdr_idx] << " rejected by camera, removed from bracket";
+		hdr_exposures.erase(hdr_exposures.begin() + hdr_idx);
+		accumulator.reset();
+		hdr_idx = 0;
+		if (hdr_exposures.empty())
+			return false;
+	}
+
+	if (info.settings.exposure == hdr_exposures[hdr_idx]) {
+		done = accumulator.bracket(img, info.settings.exposure, hdr_exposures.size());
+		hdr_idx = (hdr_idx + 1) % hdr_exposures.size();
+	}
+
+	// next frames are unsettled until requested exposure is applied
+	if (info.settings.exposure != hdr_exposures[hdr_idx])
+		queueUpdate(ParameterUpdate::Exposure, hdr_exposures[hdr_idx]);
+
+	return done;
+}
+
+bool CameraGigE::parseRegions(const std::string & str) {
+	std::vector<Region> parsed;
+
+	std::stringstream ss(str);
+	std::string item;
+	while (std::getline(ss, item, ';')) {
+		if (item.find_first_not_of(" \t") == std::string::npos)
+			continue;
+
+		size_t colon = item.find(':');
+		if (colon == std::string::npos)
+			return false;
+
+		Region region;
+		region.name = item.substr(0, colon);
+		region.name.erase(0, region.name.find_first_not_of(" \t"));
+		region.name.erase(region.name.find_last_not_of(" \t") + 1);
+		region.stream = NULL;
+
+		char sep1, sep2, sep3;
+		std::stringstream rs(item.substr(colon + 1));
+		if (!(rs >> region.rect.x >> sep1 >> region.rect.y >> sep2 >> region.rect.width >> sep3 >> region.rect.height)
+				|| sep1 != ',' || sep2 != ',' || sep3 != ',' || region.name.empty()
+				|| region.rect.x < 0 || region.rect.y < 0 || region.rect.width <= 0 || region.rect.height <= 0)
+			return false;
+
+		// out_<name> must not collide with other output streams
+		if (region.name == "img" || region.name == "info" || region.name == "stats")
+			return false;
+		for (size_t i = 0; i < parsed.size(); ++i)
+			if (parsed[i].name == region.name)
+				return false;
+
+		parsed.push_back(region);
+	}
+
+	regions.swap(parsed);
+	return true;
+}
+
+void CameraGigE::setRegionsRoi() {
+	cv::Rect box = regions[0].rect;
+	for (size_t i = 1; i < regions.size(); ++i)
+		box |= regions[i].rect;
+
+	// move origin first, so new size always fits on sensor
+	setAttrUint32("RegionX", 0);
+	setAttrUint32("RegionY", 0);
+	setAttrUint32("Width", box.width);
+	setAttrUint32("Height", box.height);
+	setAttrUint32("RegionX", box.x);
+	setAttrUint32("RegionY", box.y);
+
+	CLOG(LINFO) << "Camera ROI set to " << box.width << "x" << box.height << "+" << box.x << "+" << box.y;
+}
+
+void CameraGigE::writeRegions() {
+	cv::Rect image(0, 0, img.cols, img.rows);
+
+	for (size_t i = 0; i < regions.size(); ++i) {
+		Region & region = regions[i];
+
+		// regions are given in sensor coordinates, image starts at camera ROI
+		cv::Rect rect = (region.rect - roi_offset) & image;
+		if (rect.area() == 0)
+			continue;
+
+		if (m_regions_copy) {
+			img(rect).copyTo(region.copy[frame_idx]);
+			region.stream->write(region.copy[frame_idx]);
+		} else {
+			region.stream->write(img(rect));
+		}
 	}
 }
 
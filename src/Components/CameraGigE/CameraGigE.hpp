@@ -14,6 +14,9 @@
 
 #include <vector>
 #include <string>
+#include <deque>
+
+#include <boost/thread/mutex.hpp>
 
 #include <opencv2/opencv.hpp>
 
@@ -36,6 +39,14 @@
 
 #include <PvApi.h>
 
+#include "Types/FrameInfo.hpp"
+#include "Types/FrameStatistics.hpp"
+#include "Types/SharedFrameRing.hpp"
+#include "ExposureController.hpp"
+#include "StatisticsCalculator.hpp"
+#include "ChangeDetector.hpp"
+#include "FrameAccumulator.hpp"
+
 /**
  * \defgroup CameraGigE CameraGigE
  * \ingroup Sources
@@ -49,6 +60,14 @@
  *
  * \streamout{out_img,cv::Mat}
  * Output image
+ * \streamout{out_info,Types::FrameInfo}
+ * Settings the image was exposed with and whether pending parameter changes are already in effect.
+ * Settings in Auto/AutoOnce modes are changed by camera itself, they are read back after every frame
+ * and may lag by one frame (settled only refers to changes requested by this component).
+ * \streamout{out_<name>,cv::Mat}
+ * One stream for every region listed in regions property
+ * \streamout{out_stats,Types::FrameStatistics}
+ * Statistics of image, written only if at least one statistics.* property is enabled
  *
  *
  * \par Events:
@@ -70,21 +89,96 @@
  * \prop{UID,int,"0"}
  * UID of camera.
  *
- * \prop{Exposure.Mode,string,"Auto"}
+ * \prop{acquisition.settle_frames,int,1}
+ * Number of frames already in flight when a parameter change is applied in Continuous mode.
+ * These frames are reported with the previous settings and settled flag cleared.
+ *
+ * Changes of image.exposure.value, image.gain.value and image.whitebalance.* are queued
+ * and applied between frames, so setting them never blocks on the camera.
+ *
+ * \prop{regions,string,""}
+ * List of named sub-regions in sensor coordinates, "name:x,y,width,height;name2:x,y,width,height".
+ * Names must be unique and differ from img, info and stats, coordinates must be non-negative.
+ * Each region is written to its own out_<name> stream as a view into captured frame.
+ * \prop{regions.copy,bool,false}
+ * Write regions as contiguous copies instead of views.
+ * \prop{regions.auto_roi,bool,true}
+ * Set camera ROI to bounding box of all regions, so only needed pixels are transferred.
+ *
+ * \prop{accumulate.mode,string,"None"}
+ * Combine consecutive frames, available modes : None, Average, HDR.
+ * Average writes mean of every accumulate.frames settled frames exposed with the same settings
+ * (host-side auto exposure adjusts only between batches). HDR cycles exposure through
+ * accumulate.hdr.exposures and writes one fused, tone mapped image per bracket
+ * (host-side auto exposure is not used then). Only settled frames are used in HDR mode,
+ * set acquisition.settle_frames to 0 if camera applies exposure to next queued frame.
+ * \prop{accumulate.frames,int,4}
+ * Number of frames averaged in Average mode.
+ * \prop{accumulate.hdr.exposures,string,""}
+ * Comma separated exposure times in seconds, e.g. "0.002,0.008,0.032".
+ * \prop{accumulate.hdr.key,double,1}
+ * Tone mapping key, higher values give brighter HDR images.
+ *
+ * \prop{gating.enabled,bool,false}
+ * Publish only frames which differ from last published one. Suppressed frames are not written
+ * to any stream nor shared memory, out_info reports how many frames were suppressed.
+ * \prop{gating.threshold,double,4}
+ * Mean absolute difference (gray levels) of most changed tile needed to publish frame.
+ * \prop{gating.step,int,8}
+ * Only every step-th pixel in both directions is compared.
+ * \prop{gating.tiles,int,8}
+ * Number of tiles in each direction.
+ * \prop{gating.keyframe,int,30}
+ * Every keyframe-th frame is published even if unchanged, 0 disables keyframes.
+ *
+ * \prop{shm.name,string,""}
+ * Name of POSIX shared memory object (e.g. "/camera") frames are published to, disabled if empty.
+ * Other processes read it with Types::SharedFrameReader.
+ * \prop{shm.slots,int,4}
+ * Number of frames kept in shared memory ring.
+ *
+ * \prop{statistics.histogram,bool,false}
+ * Compute 256-bin brightness histogram.
+ * \prop{statistics.mean,bool,false}
+ * Compute mean brightness.
+ * \prop{statistics.clipped,bool,false}
+ * Count black and saturated pixels.
+ * \prop{statistics.focus,bool,false}
+ * Compute sharpness score.
+ *
+ * \prop{autoexposure.enabled,bool,false}
+ * Enable host-side auto exposure and gain. Switches camera ExposureMode and GainMode to Manual.
+ * \prop{autoexposure.target,double,128}
+ * Target mean brightness of metering window (0-255).
+ * \prop{autoexposure.saturation,double,0.01}
+ * Allowed fraction of saturated pixels in metering window.
+ * \prop{autoexposure.damping,double,0.7}
+ * Fraction of computed correction applied per frame.
+ * \prop{autoexposure.tolerance,double,0.05}
+ * Relative brightness error treated as converged.
+ * \prop{autoexposure.step,int,4}
+ * Only every step-th pixel in both directions is metered.
+ * \prop{autoexposure.window.x,int,0}
+ * \prop{autoexposure.window.y,int,0}
+ * \prop{autoexposure.window.width,int,0}
+ * \prop{autoexposure.window.height,int,0}
+ * Metering window in image coordinates (relative to camera ROI, unlike regions), whole image if width or height is 0.
+ *
+ * \prop{image.exposure.mode,string,""}
  * Control exposure mode, available modes : Manual, Auto, AutoOnce, External.
- * \prop{Exposure.Value,double,0.01}
+ * \prop{image.exposure.value,double,-1}
  * Exposure time in seconds used in Manual mode.
  *
- * \prop{Gain.Mode,string,"Auto"}
+ * \prop{image.gain.mode,string,""}
  * Control gain mode, available modes : Manual, Auto, AutoOnce.
- * \prop{Gain.Value,int,0}
+ * \prop{image.gain.value,int,0}
  * Sensor gain in dB used in Manual mode.
  *
- * \prop{Whitebal.Mode,string,"Auto"}
+ * \prop{image.whitebalance.mode,string,""}
  * Control White Balance mode, available modes : Manual, Auto, AutoOnce.
- * \prop{Whitebal.ValueRed,int,50}
+ * \prop{image.whitebalance.red,int,50}
  * Red gain expressed as a percentage of the camera default setting.
- * \prop{Whitebal.ValueBlue,int,50}
+ * \prop{image.whitebalance.blue,int,50}
  * Blue gain expressed as a percentage of the camera default setting.
  *
  * \prop{ImageFormat.PixelFormat,string,"Bgr24"}
@@ -243,6 +337,12 @@ protected:
 	/// Output data stream
 	Base::DataStreamOut<cv::Mat> out_img;
 
+	/// Metadata of image written to out_img
+	Base::DataStreamOut<Types::FrameInfo> out_info;
+
+	/// Statistics of image written to out_img
+	Base::DataStreamOut<Types::FrameStatistics> out_stats;
+
 	Base::DataStreamIn<Base::UnitType> in_trigger;
 
 	/*!
@@ -271,7 +371,202 @@ protected:
 	Base::Property<double> m_exposure_value;
 	void onExposureValueChanged(const double & old_exp, const double & new_exp);
 
+	Base::Property<std::string> m_gain_mode;
+
+	Base::Property<int> m_gain_value;
+	void onGainValueChanged(const int & old_gain, const int & new_gain);
+
+	Base::Property<std::string> m_whitebal_mode;
+
+	Base::Property<int> m_whitebal_red;
+	void onWhitebalRedChanged(const int & old_red, const int & new_red);
+
+	Base::Property<int> m_whitebal_blue;
+	void onWhitebalBlueChanged(const int & old_blue, const int & new_blue);
+
+	Base::Property<int> m_settle_frames;
+
+	Base::Property<std::string> m_regions;
+	Base::Property<bool> m_regions_copy;
+	Base::Property<bool> m_regions_auto_roi;
+
+	Base::Property<std::string> m_accumulate_mode;
+	Base::Property<int> m_accumulate_frames;
+	Base::Property<std::string> m_hdr_exposures;
+	Base::Property<double> m_hdr_key;
+
+	Base::Property<bool> m_gating_enabled;
+	Base::Property<double> m_gating_threshold;
+	Base::Property<int> m_gating_step;
+	Base::Property<int> m_gating_tiles;
+	Base::Property<int> m_gating_keyframe;
+
+	Base::Property<std::string> m_shm_name;
+	Base::Property<int> m_shm_slots;
+
+	Base::Property<bool> m_stats_histogram;
+	Base::Property<bool> m_stats_mean;
+	Base::Property<bool> m_stats_clipped;
+	Base::Property<bool> m_stats_focus;
+
+	Base::Property<bool> m_ae_enabled;
+	Base::Property<double> m_ae_target;
+	Base::Property<double> m_ae_saturation;
+	Base::Property<double> m_ae_damping;
+	Base::Property<double> m_ae_tolerance;
+	Base::Property<int> m_ae_step;
+	Base::Property<int> m_ae_window_x;
+	Base::Property<int> m_ae_window_y;
+	Base::Property<int> m_ae_window_width;
+	Base::Property<int> m_ae_window_height;
+
 private:
+	/// Named sub-region of image with its own output stream
+	struct Region {
+		std::string name;
+
+		/// Region in sensor coordinates
+		cv::Rect rect;
+
+		Base::DataStreamOut<cv::Mat> * stream;
+
+		/// Contiguous copies, alternating like frame buffers
+		cv::Mat copy[2];
+	};
+
+	/*!
+	 * Parses regions property, returns false on syntax error.
+	 */
+	bool parseRegions(const std::string & str);
+
+	/*!
+	 * Sets camera ROI to bounding box of all regions.
+	 */
+	void setRegionsRoi();
+
+	/*!
+	 * Writes all regions of current frame.
+	 */
+	void writeRegions();
+
+	std::vector<Region> regions;
+
+	/// Sensor position of top-left image pixel
+	cv::Point roi_offset;
+
+	/// Single camera parameter change waiting to be applied
+	struct ParameterUpdate {
+		enum Kind { Exposure, Gain, WhitebalRed, WhitebalBlue };
+
+		Kind kind;
+		double value;
+
+		ParameterUpdate(Kind k, double v) : kind(k), value(v) {}
+	};
+
+	/*!
+	 * Adds parameter change to queue, returns immediately.
+	 */
+	void queueUpdate(ParameterUpdate::Kind kind, double value);
+
+	/*!
+	 * Sends all queued parameter changes to camera. Called between frames.
+	 */
+	void applyPendingUpdates();
+
+	/*!
+	 * Sets integer attribute, reports valid range on failure.
+	 */
+	tPvErr setAttrUint32(const char * name, tPvUint32 value);
+
+	/*!
+	 * Fills frame metadata for currently grabbed frame.
+	 */
+	void updateFrameInfo(const tPvFrame & f);
+
+	/*!
+	 * Returns time in ms to wait for queued frame.
+	 */
+	unsigned long frameTimeout();
+
+	/*!
+	 * Checks whether given mode attribute (ExposureMode, GainMode...) is set to Manual.
+	 */
+	bool isManual(const char * mode_attr);
+
+	/*!
+	 * Runs host-side auto exposure on settled frame, queues new exposure and gain.
+	 */
+	void updateExposure();
+
+	/// Parameter changes waiting for next frame
+	std::deque<ParameterUpdate> pending_updates;
+
+	/// Guards pending_updates
+	boost::mutex updates_mutex;
+
+	/// Settings in effect before last update
+	Types::CameraSettings previous_settings;
+
+	/// Settings requested by last update
+	Types::CameraSettings current_settings;
+
+	/// Number of applied updates
+	unsigned long settings_generation;
+
+	/// Number of next grabbed frames still exposed with previous settings
+	int unsettled_frames;
+
+	/// Last exposure refused by camera, negative if none
+	double rejected_exposure;
+
+	/// Exposure is controlled by camera (mode other than Manual)
+	bool camera_exposure_auto;
+
+	/// Gain is controlled by camera
+	bool camera_gain_auto;
+
+	/// White balance is controlled by camera
+	bool camera_whitebal_auto;
+
+	/// Camera frame period in seconds, 0 if unknown
+	double frame_period;
+
+	/// Metadata of last grabbed frame
+	Types::FrameInfo info;
+
+	/// Host-side auto exposure
+	ExposureController exposure_controller;
+
+	/// Statistics of last grabbed frame
+	Types::FrameStatistics stats;
+
+	StatisticsCalculator statistics_calculator;
+
+	/*!
+	 * Adds settled frame to HDR bracket, requests exposure of next bracket frame.
+	 * \returns true if bracket is complete
+	 */
+	bool accumulateBracket();
+
+	/// Averaging and HDR fusion
+	FrameAccumulator accumulator;
+
+	/// Exposure times of HDR bracket
+	std::vector<double> hdr_exposures;
+
+	/// Index of next HDR bracket exposure
+	size_t hdr_idx;
+
+	/// Parameter generation of frames in current average batch
+	unsigned long accumulate_generation;
+
+	/// Suppression of unchanged frames
+	ChangeDetector change_detector;
+
+	/// Export of frames to other processes
+	Types::SharedFrameWriter shm_writer;
+
 	/// Camera handle
 	tPvHandle 	cHandle;
 
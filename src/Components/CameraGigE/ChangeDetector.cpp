@@ -0,0 +1,75 @@
+/*!
+ * \file ChangeDetector.cpp
+ * \brief Detection of frames differing from last published one - methods definition.
+ */
+
+#include "ChangeDetector.hpp"
+
+#include <algorithm>
+
+namespace Sources {
+namespace CameraGigE {
+
+ChangeDetector::ChangeDetector() :
+	m_step(8), m_tiles(8), m_threshold(4.0), m_keyframe(30),
+	m_change(0), m_suppressed(0), m_checked(0), m_published(0) {
+}
+
+void ChangeDetector::setGrid(int step, int tiles) {
+	m_step = std::max(step, 1);
+	m_tiles = std::max(tiles, 1);
+}
+
+void ChangeDetector::setThreshold(double threshold, int keyframe) {
+	m_threshold = threshold;
+	m_keyframe = keyframe;
+}
+
+double ChangeDetector::suppressionRatio() const {
+	if (m_checked == 0)
+		return 0;
+	return 1.0 - (double) m_published / m_checked;
+}
+
+bool ChangeDetector::check(const cv::Mat & img) {
+	++m_checked;
+
+	cv::Size size(std::max(img.cols / m_step, 1), std::max(img.rows / m_step, 1));
+	cv::resize(img, m_sample, size, 0, 0, cv::INTER_NEAREST);
+
+	if (m_sample.channels() == 3) {
+		cv::cvtColor(m_sample, m_gray, CV_BGR2GRAY);
+	} else {
+		m_sample.copyTo(m_gray);
+	}
+
+	bool publish;
+	if (m_reference.size() != m_gray.size() || m_reference.type() != m_gray.type()) {
+		// first frame or geometry changed
+		m_change = 0;
+		publish = true;
+	} else {
+		cv::absdiff(m_gray, m_reference, m_diff);
+
+		// area resize averages every tile
+		cv::Size tiles(std::min(m_tiles, m_diff.cols), std::min(m_tiles, m_diff.rows));
+		cv::resize(m_diff, m_tile_diff, tiles, 0, 0, cv::INTER_AREA);
+		cv::minMaxLoc(m_tile_diff, NULL, &m_change);
+
+		publish = (m_change > m_threshold) || (m_keyframe > 0 && (int) m_suppressed + 1 >= m_keyframe);
+	}
+
+	if (publish) {
+		// buffers are swapped, not reallocated
+		std::swap(m_reference, m_gray);
+		m_suppressed = 0;
+		++m_published;
+	} else {
+		++m_suppressed;
+	}
+
+	return publish;
+}
+
+}//: namespace CameraGigE
+}//: namespace Sources
@@ -0,0 +1,83 @@
+/*!
+ * \file ChangeDetector.hpp
+ * \brief Detection of frames differing from last published one - class declaration.
+ */
+
+#ifndef CHANGEDETECTOR_HPP_
+#define CHANGEDETECTOR_HPP_
+
+#include <opencv2/opencv.hpp>
+
+namespace Sources {
+namespace CameraGigE {
+
+/*!
+ * \class ChangeDetector
+ * \brief Decides whether frame differs enough from reference to be published.
+ *
+ * Frame is sampled every step-th pixel and compared with reference (last
+ * published frame) using sum of absolute differences computed per tile of a
+ * grid, so small local changes are not averaged out by static background.
+ * Every keyframe-th frame is published regardless of change.
+ */
+class ChangeDetector {
+public:
+	ChangeDetector();
+
+	/*!
+	 * Sets subsampling step and number of tiles in each direction.
+	 */
+	void setGrid(int step, int tiles);
+
+	/*!
+	 * Sets mean absolute difference (in gray levels) of most changed tile
+	 * needed to publish frame, and keyframe interval (0 - no keyframes).
+	 */
+	void setThreshold(double threshold, int keyframe);
+
+	/*!
+	 * Compares image with reference, updates reference if frame is to be published.
+	 * \returns true if frame should be published
+	 */
+	bool check(const cv::Mat & img);
+
+	/// Change score of last checked frame
+	double change() const { return m_change; }
+
+	/// Frames suppressed since last published one
+	unsigned long suppressed() const { return m_suppressed; }
+
+	/// Fraction of all checked frames which were suppressed
+	double suppressionRatio() const;
+
+private:
+	int m_step;
+	int m_tiles;
+	double m_threshold;
+	int m_keyframe;
+
+	/// Subsampled frame
+	cv::Mat m_sample;
+
+	/// Subsampled frame converted to gray
+	cv::Mat m_gray;
+
+	/// Gray sample of last published frame
+	cv::Mat m_reference;
+
+	/// Absolute difference to reference
+	cv::Mat m_diff;
+
+	/// Mean absolute difference of every tile
+	cv::Mat m_tile_diff;
+
+	double m_change;
+	unsigned long m_suppressed;
+	unsigned long m_checked;
+	unsigned long m_published;
+};
+
+}//: namespace CameraGigE
+}//: namespace Sources
+
+#endif /* CHANGEDETECTOR_HPP_ */
@@ -0,0 +1,124 @@
+/*!
+ * \file ExposureController.cpp
+ * \brief Host-side auto exposure and auto gain controller - methods definition.
+ */
+
+#include "ExposureController.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Sources {
+namespace CameraGigE {
+
+ExposureController::ExposureController() :
+	m_target(128), m_max_saturation(0.01), m_step(4), m_damping(0.7), m_tolerance(0.05),
+	m_exposure_min(0.00001), m_exposure_max(1.0), m_gain_min(0), m_gain_max(0),
+	m_brightness(0), m_saturated(0), m_converged(false),
+	m_unsettled_frames(0), m_convergence_frames(0), m_ticks(0), m_updates(0) {
+}
+
+void ExposureController::setTarget(double brightness, double saturation) {
+	m_target = brightness;
+	m_max_saturation = saturation;
+}
+
+void ExposureController::setWindow(const cv::Rect & window, int step) {
+	m_window = window;
+	m_step = std::max(step, 1);
+}
+
+void ExposureController::setDamping(double damping, double tolerance) {
+	m_damping = damping;
+	m_tolerance = tolerance;
+}
+
+void ExposureController::setExposureRange(double min, double max) {
+	m_exposure_min = min;
+	m_exposure_max = max;
+}
+
+void ExposureController::setGainRange(int min, int max) {
+	m_gain_min = min;
+	m_gain_max = max;
+}
+
+void ExposureController::countFrame() {
+	if (!m_converged)
+		++m_unsettled_frames;
+}
+
+double ExposureController::averageCost() const {
+	if (m_updates == 0)
+		return 0;
+	return (double) m_ticks / cv::getTickFrequency() / m_updates;
+}
+
+void ExposureController::meter(const cv::Mat & img) {
+	cv::Rect window = m_window & cv::Rect(0, 0, img.cols, img.rows);
+	if (window.area() == 0)
+		window = cv::Rect(0, 0, img.cols, img.rows);
+
+	// nearest neighbour resize picks every step-th pixel, buffers are reused between frames
+	cv::Size size(std::max(window.width / m_step, 1), std::max(window.height / m_step, 1));
+	cv::resize(img(window), m_sample, size, 0, 0, cv::INTER_NEAREST);
+
+	if (m_sample.channels() == 3) {
+		cv::cvtColor(m_sample, m_gray, CV_BGR2GRAY);
+	} else {
+		m_gray = m_sample;
+	}
+
+	m_brightness = cv::mean(m_gray)[0];
+
+	cv::threshold(m_gray, m_mask, 254, 255, cv::THRESH_BINARY);
+	m_saturated = (double) cv::countNonZero(m_mask) / m_mask.total();
+}
+
+bool ExposureController::update(const cv::Mat & img, const Types::CameraSettings & current, Types::CameraSettings & next) {
+	int64 start = cv::getTickCount();
+
+	meter(img);
+
+	double ratio = m_target / std::max(m_brightness, 1.0);
+	if (m_saturated > m_max_saturation) {
+		// too many clipped pixels, darken even if mean is below target
+		ratio = std::min(ratio, std::max(m_max_saturation / m_saturated, 0.5));
+	}
+
+	bool was_converged = m_converged;
+	m_converged = (std::fabs(ratio - 1.0) <= m_tolerance) && (m_saturated <= m_max_saturation);
+
+	next = current;
+
+	if (m_converged) {
+		if (!was_converged) {
+			m_convergence_frames = m_unsettled_frames;
+			m_unsettled_frames = 0;
+		}
+	} else {
+		double exposure = std::max(current.exposure, m_exposure_min);
+		double db = 20.0 * std::log10(std::pow(ratio, m_damping));
+
+		if (db > 0) {
+			// brighten - longer exposure first, then gain
+			next.exposure = std::min(exposure * std::pow(10.0, db / 20.0), m_exposure_max);
+			db -= 20.0 * std::log10(next.exposure / exposure);
+			next.gain = std::min(current.gain + (int) floor(db + 0.5), m_gain_max);
+		} else {
+			// darken - lower gain first, then exposure
+			next.gain = std::max(current.gain + (int) floor(db + 0.5), m_gain_min);
+			db -= next.gain - current.gain;
+			next.exposure = std::max(exposure * std::pow(10.0, db / 20.0), m_exposure_min);
+		}
+		next.gain = std::max(next.gain, m_gain_min);
+	}
+
+	m_ticks += cv::getTickCount() - start;
+	++m_updates;
+
+	return (next.exposure != current.exposure) || (next.gain != current.gain);
+}
+
+}//: namespace CameraGigE
+}//: namespace Sources
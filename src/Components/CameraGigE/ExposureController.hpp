@@ -0,0 +1,124 @@
+/*!
+ * \file ExposureController.hpp
+ * \brief Host-side auto exposure and auto gain controller - class declaration.
+ */
+
+#ifndef EXPOSURECONTROLLER_HPP_
+#define EXPOSURECONTROLLER_HPP_
+
+#include <opencv2/opencv.hpp>
+
+#include "Types/FrameInfo.hpp"
+
+namespace Sources {
+namespace CameraGigE {
+
+/*!
+ * \class ExposureController
+ * \brief Drives exposure time and gain toward target brightness.
+ *
+ * Brightness is metered over a window of the image, sampled every step-th
+ * pixel in both directions. Exposure is changed first, gain is used only
+ * when exposure hits its limit (and is reduced first when image is too bright).
+ * Work buffers are kept between frames, so metering does not allocate once
+ * frame size is stable.
+ */
+class ExposureController {
+public:
+	ExposureController();
+
+	/*!
+	 * Sets target mean brightness (0-255) and allowed fraction of saturated samples.
+	 */
+	void setTarget(double brightness, double saturation);
+
+	/*!
+	 * Sets metering window (empty means whole image) and subsampling step.
+	 */
+	void setWindow(const cv::Rect & window, int step);
+
+	/*!
+	 * Sets fraction of computed correction applied per update and relative brightness
+	 * error treated as converged.
+	 */
+	void setDamping(double damping, double tolerance);
+
+	/// Sets valid exposure range in seconds
+	void setExposureRange(double min, double max);
+
+	/// Sets valid gain range in dB
+	void setGainRange(int min, int max);
+
+	/*!
+	 * Meters image and computes new settings.
+	 * \param img image exposed with current settings
+	 * \param current settings used for img
+	 * \param next computed settings
+	 * \returns true if next differs from current
+	 */
+	bool update(const cv::Mat & img, const Types::CameraSettings & current, Types::CameraSettings & next);
+
+	/*!
+	 * Counts grabbed frame toward convergence time. Call for every frame,
+	 * including those not passed to update().
+	 */
+	void countFrame();
+
+	/// Mean brightness of last metered image
+	double brightness() const { return m_brightness; }
+
+	/// Fraction of saturated samples in last metered image
+	double saturation() const { return m_saturated; }
+
+	/// True if last metered image was within tolerance
+	bool converged() const { return m_converged; }
+
+	/// Number of grabbed frames needed to reach tolerance after last disturbance
+	unsigned long convergenceFrames() const { return m_convergence_frames; }
+
+	/// Average metering and control time per frame in seconds
+	double averageCost() const;
+
+private:
+	/*!
+	 * Computes mean brightness and saturated fraction of metering window.
+	 */
+	void meter(const cv::Mat & img);
+
+	double m_target;
+	double m_max_saturation;
+	cv::Rect m_window;
+	int m_step;
+	double m_damping;
+	double m_tolerance;
+	double m_exposure_min;
+	double m_exposure_max;
+	int m_gain_min;
+	int m_gain_max;
+
+	/// Subsampled metering window
+	cv::Mat m_sample;
+
+	/// Subsampled window converted to gray
+	cv::Mat m_gray;
+
+	/// Saturated samples
+	cv::Mat m_mask;
+
+	double m_brightness;
+	double m_saturated;
+
+	bool m_converged;
+
+	/// Grabbed frames since brightness left tolerance
+	unsigned long m_unsettled_frames;
+	unsigned long m_convergence_frames;
+
+	int64 m_ticks;
+	unsigned long m_updates;
+};
+
+}//: namespace CameraGigE
+}//: namespace Sources
+
+#endif /* EXPOSURECONTROLLER_HPP_ */
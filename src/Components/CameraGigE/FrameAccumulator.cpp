@@ -0,0 +1,108 @@
+/*!
+ * \file FrameAccumulator.cpp
+ * \brief Temporal averaging and HDR fusion of consecutive frames - methods definition.
+ */
+
+#include "FrameAccumulator.hpp"
+
+namespace Sources {
+namespace CameraGigE {
+
+FrameAccumulator::FrameAccumulator() :
+	m_output_idx(0), m_count(0), m_key(1.0) {
+}
+
+void FrameAccumulator::allocate(const cv::Size & size, int type) {
+	int channels = CV_MAT_CN(type);
+
+	// create() does nothing if buffer already has requested size and type
+	m_sum.create(size, CV_32FC(channels));
+	m_weight_sum.create(size, CV_32FC(channels));
+	m_frame.create(size, CV_32FC(channels));
+	m_weight.create(size, CV_32FC(channels));
+	m_tmp.create(size, CV_32FC(channels));
+	m_output[0].create(size, type);
+	m_output[1].create(size, type);
+}
+
+void FrameAccumulator::setKey(double key) {
+	m_key = key;
+}
+
+void FrameAccumulator::reset() {
+	m_count = 0;
+}
+
+bool FrameAccumulator::average(const cv::Mat & img, int frames) {
+	if (img.size() != m_sum.size() || img.channels() != m_sum.channels()) {
+		allocate(img.size(), img.type());
+		m_count = 0;
+	}
+
+	if (m_count == 0)
+		m_sum.setTo(cv::Scalar::all(0));
+
+	cv::accumulate(img, m_sum);
+
+	if (++m_count < frames)
+		return false;
+
+	m_output_idx = 1 - m_output_idx;
+	m_sum.convertTo(m_output[m_output_idx], img.type(), 1.0 / m_count);
+	m_count = 0;
+
+	return true;
+}
+
+bool FrameAccumulator::bracket(const cv::Mat & img, double exposure, int count) {
+	if (img.size() != m_sum.size() || img.channels() != m_sum.channels()) {
+		allocate(img.size(), img.type());
+		m_count = 0;
+	}
+
+	if (m_count == 0) {
+		m_sum.setTo(cv::Scalar::all(0));
+		m_weight_sum.setTo(cv::Scalar::all(0));
+	}
+
+	img.convertTo(m_frame, CV_32F);
+
+	// hat weighting, pixels close to black or saturation are least reliable
+	cv::absdiff(m_frame, cv::Scalar::all(127.5), m_weight);
+	cv::subtract(cv::Scalar::all(128.0), m_weight, m_weight);
+
+	// radiance estimate is pixel value divided by exposure time
+	cv::multiply(m_frame, m_weight, m_tmp, 1.0 / exposure);
+	cv::add(m_sum, m_tmp, m_sum);
+	cv::add(m_weight_sum, m_weight, m_weight_sum);
+
+	if (++m_count < count)
+		return false;
+
+	fuse();
+	m_count = 0;
+
+	return true;
+}
+
+void FrameAccumulator::fuse() {
+	cv::divide(m_sum, m_weight_sum, m_tmp);
+
+	cv::Scalar mean = cv::mean(m_tmp);
+	double luminance = 0;
+	for (int i = 0; i < m_tmp.channels(); ++i)
+		luminance += mean[i];
+	luminance /= m_tmp.channels();
+
+	// global Reinhard operator, L / (1 + L) with mean scaled to key
+	if (luminance > 0)
+		m_tmp.convertTo(m_tmp, -1, m_key / luminance);
+	cv::add(m_tmp, cv::Scalar::all(1.0), m_frame);
+	cv::divide(m_tmp, m_frame, m_tmp);
+
+	m_output_idx = 1 - m_output_idx;
+	m_tmp.convertTo(m_output[m_output_idx], m_output[m_output_idx].type(), 255.0);
+}
+
+}//: namespace CameraGigE
+}//: namespace Sources
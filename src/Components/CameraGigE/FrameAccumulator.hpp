@@ -0,0 +1,93 @@
+/*!
+ * \file FrameAccumulator.hpp
+ * \brief Temporal averaging and HDR fusion of consecutive frames - class declaration.
+ */
+
+#ifndef FRAMEACCUMULATOR_HPP_
+#define FRAMEACCUMULATOR_HPP_
+
+#include <opencv2/opencv.hpp>
+
+namespace Sources {
+namespace CameraGigE {
+
+/*!
+ * \class FrameAccumulator
+ * \brief Combines several 8-bit frames into one.
+ *
+ * In averaging mode frames are summed into floating point accumulator and
+ * mean of every batch is emitted. In HDR mode frames exposed with different
+ * exposure times are fused into radiance map (each pixel weighted by its
+ * distance from black and saturation) and tone mapped back to 8 bits.
+ * All buffers are allocated up front by allocate(), results are kept in two
+ * alternating buffers, like camera frames.
+ */
+class FrameAccumulator {
+public:
+	FrameAccumulator();
+
+	/*!
+	 * Allocates buffers for frames of given size and type (CV_8UC1 or CV_8UC3).
+	 */
+	void allocate(const cv::Size & size, int type);
+
+	/*!
+	 * Sets tone mapping key, mean radiance is scaled to it before L / (1 + L) compression.
+	 */
+	void setKey(double key);
+
+	/*!
+	 * Drops partially accumulated batch.
+	 */
+	void reset();
+
+	/*!
+	 * Adds frame to average.
+	 * \returns true if frames frames were accumulated, average is in result()
+	 */
+	bool average(const cv::Mat & img, int frames);
+
+	/*!
+	 * Adds frame exposed with given exposure time to HDR bracket.
+	 * \returns true if bracket of count frames is complete, fused image is in result()
+	 */
+	bool bracket(const cv::Mat & img, double exposure, int count);
+
+	/// Number of frames in current batch
+	int count() const { return m_count; }
+
+	/// Last emitted image
+	const cv::Mat & result() const { return m_output[m_output_idx]; }
+
+private:
+	/*!
+	 * Fuses accumulated bracket to result.
+	 */
+	void fuse();
+
+	/// Sum of frames (averaging) or weighted radiance (HDR)
+	cv::Mat m_sum;
+
+	/// Sum of HDR weights
+	cv::Mat m_weight_sum;
+
+	/// Frame converted to float
+	cv::Mat m_frame;
+
+	/// HDR weights of current frame
+	cv::Mat m_weight;
+
+	cv::Mat m_tmp;
+
+	cv::Mat m_output[2];
+	int m_output_idx;
+
+	int m_count;
+
+	double m_key;
+};
+
+}//: namespace CameraGigE
+}//: namespace Sources
+
+#endif /* FRAMEACCUMULATOR_HPP_ */
@@ -0,0 +1,135 @@
+/*!
+ * \file StatisticsCalculator.cpp
+ * \brief Fused computation of frame statistics - methods definition.
+ */
+
+#include "StatisticsCalculator.hpp"
+
+#include <cstring>
+
+namespace Sources {
+namespace CameraGigE {
+
+StatisticsCalculator::StatisticsCalculator() {
+	memset(m_hist, 0, sizeof(m_hist));
+}
+
+void StatisticsCalculator::compute(const cv::Mat & img, int flags, Types::FrameStatistics & stats) {
+	stats.mean = 0;
+	stats.clippedLow = 0;
+	stats.clippedHigh = 0;
+	stats.focus = 0;
+
+	if (!(flags & Histogram))
+		stats.histogram.clear();
+
+	if (!flags || img.empty() || img.depth() != CV_8U)
+		return;
+
+	const int cols = img.cols;
+	const int rows = img.rows;
+	const bool color = (img.channels() == 3);
+
+	if (color) {
+		m_luma.resize(cols);
+		m_prev_luma.resize(cols);
+	}
+
+	if (flags & Histogram)
+		memset(m_hist, 0, sizeof(m_hist));
+
+	unsigned long long sum = 0;
+	unsigned long long grad = 0;
+	unsigned long low = 0;
+	unsigned long high = 0;
+
+	const unsigned char * prev = NULL;
+
+	for (int y = 0; y < rows; ++y) {
+		const unsigned char * row;
+
+		if (color) {
+			const unsigned char * bgr = img.ptr<unsigned char>(y);
+			unsigned char * luma = &m_luma[0];
+			for (int x = 0; x < cols; ++x) {
+				luma[x] = (29 * bgr[3*x] + 150 * bgr[3*x+1] + 77 * bgr[3*x+2] + 128) >> 8;
+			}
+			row = luma;
+		} else {
+			row = img.ptr<unsigned char>(y);
+		}
+
+		if (flags & Histogram) {
+			int x = 0;
+			for (; x + 4 <= cols; x += 4) {
+				++m_hist[0][row[x]];
+				++m_hist[1][row[x+1]];
+				++m_hist[2][row[x+2]];
+				++m_hist[3][row[x+3]];
+			}
+			for (; x < cols; ++x)
+				++m_hist[0][row[x]];
+		}
+
+		if (flags & Mean) {
+			unsigned int row_sum = 0;
+			for (int x = 0; x < cols; ++x)
+				row_sum += row[x];
+			sum += row_sum;
+		}
+
+		if (flags & Clipped) {
+			unsigned int row_low = 0, row_high = 0;
+			for (int x = 0; x < cols; ++x) {
+				row_low += (row[x] == 0);
+				row_high += (row[x] == 255);
+			}
+			low += row_low;
+			high += row_high;
+		}
+
+		if (flags & Focus) {
+			unsigned long long row_grad = 0;
+			for (int x = 0; x < cols - 1; ++x) {
+				int dx = row[x+1] - row[x];
+				row_grad += dx * dx;
+			}
+			if (prev) {
+				for (int x = 0; x < cols; ++x) {
+					int dy = row[x] - prev[x];
+					row_grad += dy * dy;
+				}
+			}
+			grad += row_grad;
+		}
+
+		if (color) {
+			m_luma.swap(m_prev_luma);
+			prev = &m_prev_luma[0];
+		} else {
+			prev = row;
+		}
+	}
+
+	const double pixels = (double) rows * cols;
+
+	if (flags & Histogram) {
+		stats.histogram.resize(256);
+		for (int i = 0; i < 256; ++i)
+			stats.histogram[i] = m_hist[0][i] + m_hist[1][i] + m_hist[2][i] + m_hist[3][i];
+	}
+
+	if (flags & Mean)
+		stats.mean = sum / pixels;
+
+	if (flags & Clipped) {
+		stats.clippedLow = low;
+		stats.clippedHigh = high;
+	}
+
+	if (flags & Focus)
+		stats.focus = grad / pixels;
+}
+
+}//: namespace CameraGigE
+}//: namespace Sources
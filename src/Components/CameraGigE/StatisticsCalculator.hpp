@@ -0,0 +1,58 @@
+/*!
+ * \file StatisticsCalculator.hpp
+ * \brief Fused computation of frame statistics - class declaration.
+ */
+
+#ifndef STATISTICSCALCULATOR_HPP_
+#define STATISTICSCALCULATOR_HPP_
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "Types/FrameStatistics.hpp"
+
+namespace Sources {
+namespace CameraGigE {
+
+/*!
+ * \class StatisticsCalculator
+ * \brief Computes histogram, mean, clipped pixels and focus in one pass.
+ *
+ * Frame is traversed once, row by row. Every enabled statistic runs its own
+ * tight loop over the current row while it is still in L1 cache, so the loops
+ * stay simple enough for the compiler to vectorize. Color rows are first
+ * converted to luma into a buffer reused between frames.
+ */
+class StatisticsCalculator {
+public:
+	/// Statistics to compute, can be combined
+	enum {
+		Histogram = 1,
+		Mean = 2,
+		Clipped = 4,
+		Focus = 8
+	};
+
+	StatisticsCalculator();
+
+	/*!
+	 * Computes selected statistics of 8-bit mono or BGR image.
+	 */
+	void compute(const cv::Mat & img, int flags, Types::FrameStatistics & stats);
+
+private:
+	/// Luma of current row (color images only)
+	std::vector<unsigned char> m_luma;
+
+	/// Luma of previous row (color images only)
+	std::vector<unsigned char> m_prev_luma;
+
+	/// Interleaved partial histograms, avoid stalls on repeated bins
+	unsigned int m_hist[4][256];
+};
+
+}//: namespace CameraGigE
+}//: namespace Sources
+
+#endif /* STATISTICSCALCULATOR_HPP_ */
@@ -0,0 +1,63 @@
+/*!
+ * \file FrameInfo.hpp
+ * \brief Per-frame acquisition metadata produced by CameraGigE.
+ */
+
+#ifndef FRAMEINFO_HPP_
+#define FRAMEINFO_HPP_
+
+namespace Types {
+
+/*!
+ * \struct CameraSettings
+ * \brief Sensor settings a frame was exposed with.
+ */
+struct CameraSettings {
+	/// Exposure time in seconds
+	double exposure;
+
+	/// Sensor gain in dB
+	int gain;
+
+	/// Red white balance gain, percentage of the camera default
+	int whitebalRed;
+
+	/// Blue white balance gain, percentage of the camera default
+	int whitebalBlue;
+
+	CameraSettings() :
+		exposure(0), gain(0), whitebalRed(0), whitebalBlue(0) {
+	}
+};
+
+/*!
+ * \struct FrameInfo
+ * \brief Metadata delivered alongside each image.
+ */
+struct FrameInfo {
+	/// Frame counter reported by the camera
+	unsigned long frameCount;
+
+	/// Camera timestamp (ticks since camera power up)
+	unsigned long long timestamp;
+
+	/// Settings the frame was exposed with
+	CameraSettings settings;
+
+	/// Number of parameter updates applied before this frame
+	unsigned long generation;
+
+	/// True once all pending parameter updates are in effect
+	bool settled;
+
+	/// Frames suppressed by change gating since previous delivered frame
+	unsigned long suppressed;
+
+	FrameInfo() :
+		frameCount(0), timestamp(0), generation(0), settled(true), suppressed(0) {
+	}
+};
+
+}//: namespace Types
+
+#endif /* FRAMEINFO_HPP_ */
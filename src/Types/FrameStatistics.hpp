@@ -0,0 +1,46 @@
+/*!
+ * \file FrameStatistics.hpp
+ * \brief Image statistics computed by CameraGigE during capture.
+ */
+
+#ifndef FRAMESTATISTICS_HPP_
+#define FRAMESTATISTICS_HPP_
+
+#include <vector>
+
+namespace Types {
+
+/*!
+ * \struct FrameStatistics
+ * \brief Brightness statistics of single frame.
+ *
+ * Color frames are measured on their luma. Statistics which were not enabled
+ * in the component are left empty or zero.
+ */
+struct FrameStatistics {
+	/// Frame counter reported by the camera, matches FrameInfo::frameCount
+	unsigned long frameCount;
+
+	/// 256-bin brightness histogram
+	std::vector<unsigned int> histogram;
+
+	/// Mean brightness (0-255)
+	double mean;
+
+	/// Number of black (0) pixels
+	unsigned long clippedLow;
+
+	/// Number of saturated (255) pixels
+	unsigned long clippedHigh;
+
+	/// Sharpness, mean squared horizontal and vertical gradient
+	double focus;
+
+	FrameStatistics() :
+		frameCount(0), mean(0), clippedLow(0), clippedHigh(0), focus(0) {
+	}
+};
+
+}//: namespace Types
+
+#endif /* FRAMESTATISTICS_HPP_ */
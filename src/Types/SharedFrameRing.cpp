@@ -0,0 +1,272 @@
+/*!
+ * \file SharedFrameRing.cpp
+ * \brief POSIX shared memory ring buffer - methods definition.
+ */
+
+#include "SharedFrameRing.hpp"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Types {
+
+namespace {
+
+const uint32_t SHARED_RING_MAGIC = 0x47694745; // "GiGE"
+const uint32_t SHARED_RING_VERSION = 2;
+
+/// Slots and image data are cache line aligned
+size_t align(size_t size) {
+	return (size + 63) & ~(size_t) 63;
+}
+
+SharedSlotHeader * slotAt(SharedRingHeader * header, uint64_t seq) {
+	char * base = (char *) header + align(sizeof(SharedRingHeader));
+	return (SharedSlotHeader *) (base + (seq % header->slotCount) * header->slotStride);
+}
+
+unsigned char * slotData(SharedSlotHeader * slot) {
+	return (unsigned char *) slot + align(sizeof(SharedSlotHeader));
+}
+
+}
+
+SharedFrameWriter::SharedFrameWriter() :
+	m_header(NULL), m_size(0) {
+}
+
+SharedFrameWriter::~SharedFrameWriter() {
+	destroy();
+}
+
+bool SharedFrameWriter::create(const std::string & name, unsigned int slots, unsigned int slot_size) {
+	destroy();
+
+	if (slots == 0)
+		return false;
+
+	size_t stride = align(sizeof(SharedSlotHeader)) + align(slot_size);
+	size_t size = align(sizeof(SharedRingHeader)) + slots * stride;
+
+	// readers still attached to previous object keep it until they detach
+	shm_unlink(name.c_str());
+
+	int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0)
+		return false;
+
+	if (ftruncate(fd, size) != 0) {
+		close(fd);
+		shm_unlink(name.c_str());
+		return false;
+	}
+
+	void * mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mem == MAP_FAILED) {
+		shm_unlink(name.c_str());
+		return false;
+	}
+
+	memset(mem, 0, size);
+
+	m_header = (SharedRingHeader *) mem;
+	m_header->version = SHARED_RING_VERSION;
+	m_header->slotCount = slots;
+	m_header->slotSize = slot_size;
+	m_header->slotStride = stride;
+	m_header->writeSeq = 0;
+	__sync_synchronize();
+	m_header->magic = SHARED_RING_MAGIC;
+
+	m_name = name;
+	m_size = size;
+
+	return true;
+}
+
+void SharedFrameWriter::destroy() {
+	if (!m_header)
+		return;
+
+	m_header->magic = 0;
+	__sync_synchronize();
+	munmap(m_header, m_size);
+	shm_unlink(m_name.c_str());
+
+	m_header = NULL;
+	m_size = 0;
+}
+
+bool SharedFrameWriter::publish(const void * data, unsigned int width, unsigned int height, unsigned int type,
+		unsigned int step, const FrameInfo & info) {
+	if (!m_header)
+		return false;
+
+	unsigned int size = height * step;
+	if (size > m_header->slotSize)
+		return false;
+
+	uint64_t seq = m_header->writeSeq;
+	SharedSlotHeader * slot = slotAt(m_header, seq);
+
+	slot->seq = 2 * seq + 1;
+	__sync_synchronize();
+
+	slot->width = width;
+	slot->height = height;
+	slot->type = type;
+	slot->step = step;
+	slot->size = size;
+	slot->settled = info.settled;
+	slot->frameCount = info.frameCount;
+	slot->timestamp = info.timestamp;
+	slot->exposure = info.settings.exposure;
+	slot->gain = info.settings.gain;
+	slot->whitebalRed = info.settings.whitebalRed;
+	slot->whitebalBlue = info.settings.whitebalBlue;
+	slot->generation = info.generation;
+	slot->suppressed = info.suppressed;
+	memcpy(slotData(slot), data, size);
+
+	__sync_synchronize();
+	slot->seq = 2 * seq + 2;
+	__sync_synchronize();
+	m_header->writeSeq = seq + 1;
+
+	return true;
+}
+
+SharedFrameReader::SharedFrameReader() :
+	m_header(NULL), m_size(0), m_next(0), m_lost(0) {
+}
+
+SharedFrameReader::~SharedFrameReader() {
+	detach();
+}
+
+bool SharedFrameReader::attach(const std::string & name) {
+	detach();
+
+	int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(SharedRingHeader)) {
+		close(fd);
+		return false;
+	}
+
+	void * mem = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mem == MAP_FAILED)
+		return false;
+
+	SharedRingHeader * header = (SharedRingHeader *) mem;
+	__sync_synchronize();
+	if (header->magic != SHARED_RING_MAGIC || header->version != SHARED_RING_VERSION) {
+		munmap(mem, st.st_size);
+		return false;
+	}
+
+	m_header = header;
+	m_size = st.st_size;
+	m_next = m_header->writeSeq;
+	m_lost = 0;
+
+	return true;
+}
+
+void SharedFrameReader::detach() {
+	if (!m_header)
+		return;
+
+	munmap(m_header, m_size);
+	m_header = NULL;
+	m_size = 0;
+}
+
+SharedFrameReader::Status SharedFrameReader::read(SharedFrame & frame) {
+	if (!m_header)
+		return NoData;
+
+	Status status = Ok;
+
+	for (;;) {
+		// cleared by producer in destroy(), new object would have different mapping
+		if (m_header->magic != SHARED_RING_MAGIC) {
+			detach();
+			return Closed;
+		}
+
+		uint64_t written = m_header->writeSeq;
+		__sync_synchronize();
+
+		// frame is left untouched
+		if (m_next >= written)
+			return NoData;
+
+		// oldest frames were already overwritten
+		if (written - m_next > m_header->slotCount) {
+			m_lost += written - m_header->slotCount - m_next;
+			m_next = written - m_header->slotCount;
+			status = Overrun;
+		}
+
+		SharedSlotHeader * slot = slotAt(m_header, m_next);
+
+		uint64_t begin = slot->seq;
+		__sync_synchronize();
+
+		if (begin != 2 * m_next + 2) {
+			// slot is being overwritten by newer frame
+			++m_lost;
+			++m_next;
+			status = Overrun;
+			continue;
+		}
+
+		frame.seq = m_next;
+		frame.width = slot->width;
+		frame.height = slot->height;
+		frame.type = slot->type;
+		frame.step = slot->step;
+		frame.info.settled = slot->settled;
+		frame.info.frameCount = slot->frameCount;
+		frame.info.timestamp = slot->timestamp;
+		frame.info.settings.exposure = slot->exposure;
+		frame.info.settings.gain = slot->gain;
+		frame.info.settings.whitebalRed = slot->whitebalRed;
+		frame.info.settings.whitebalBlue = slot->whitebalBlue;
+		frame.info.generation = slot->generation;
+		frame.info.suppressed = slot->suppressed;
+
+		uint32_t size = slot->size;
+		if (size > m_header->slotSize)
+			size = m_header->slotSize;
+		frame.data.resize(size);
+		if (size)
+			memcpy(&frame.data[0], slotData(slot), size);
+
+		__sync_synchronize();
+		uint64_t end = slot->seq;
+
+		if (end != begin) {
+			// overwritten while copying
+			++m_lost;
+			++m_next;
+			status = Overrun;
+			continue;
+		}
+
+		++m_next;
+		return status;
+	}
+}
+
+}//: namespace Types
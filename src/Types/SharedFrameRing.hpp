@@ -0,0 +1,185 @@
+/*!
+ * \file SharedFrameRing.hpp
+ * \brief POSIX shared memory ring buffer used to export frames to other processes.
+ *
+ * Producer never waits for readers. Every slot is guarded by its own sequence
+ * counter (seqlock), readers copy the slot and check that the counter did not
+ * change while copying, so they can attach, detach and detect overruns at any
+ * time without any communication with the producer. When producer destroys
+ * (or recreates) the ring, attached readers get Closed and should attach again.
+ *
+ * Link against CameraGigETypes (and rt) to use it outside DisCODe.
+ */
+
+#ifndef SHAREDFRAMERING_HPP_
+#define SHAREDFRAMERING_HPP_
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "FrameInfo.hpp"
+
+namespace Types {
+
+/// Ring header, placed at the beginning of shared memory
+struct SharedRingHeader {
+	/// SHARED_RING_MAGIC once producer finished initialization
+	volatile uint32_t magic;
+	uint32_t version;
+
+	/// Number of slots
+	uint32_t slotCount;
+
+	/// Maximal image size in bytes
+	uint32_t slotSize;
+
+	/// Distance between slots in bytes
+	uint32_t slotStride;
+
+	uint32_t reserved;
+
+	/// Number of frames published so far
+	volatile uint64_t writeSeq;
+};
+
+/// Slot header, followed by image data
+struct SharedSlotHeader {
+	/// 2*n+1 while frame n is written, 2*n+2 once it is complete
+	volatile uint64_t seq;
+
+	/// Image geometry, type is OpenCV type (CV_8UC1, CV_8UC3...)
+	uint32_t width;
+	uint32_t height;
+	uint32_t type;
+	uint32_t step;
+	uint32_t size;
+
+	/// Frame metadata
+	uint32_t settled;
+	uint64_t frameCount;
+	uint64_t timestamp;
+	double exposure;
+	int32_t gain;
+	int32_t whitebalRed;
+	int32_t whitebalBlue;
+	uint32_t reserved;
+	uint64_t generation;
+	uint64_t suppressed;
+};
+
+/// Frame read from ring
+struct SharedFrame {
+	/// Sequence number of frame in ring
+	uint64_t seq;
+
+	uint32_t width;
+	uint32_t height;
+	uint32_t type;
+	uint32_t step;
+
+	FrameInfo info;
+
+	/// Image data, step bytes per row
+	std::vector<unsigned char> data;
+};
+
+/*!
+ * \class SharedFrameWriter
+ * \brief Publishes frames into shared memory ring.
+ */
+class SharedFrameWriter {
+public:
+	SharedFrameWriter();
+
+	~SharedFrameWriter();
+
+	/*!
+	 * Creates (or recreates) shared memory object.
+	 * \param name shared memory object name, e.g. "/camera"
+	 * \param slots number of frames kept in ring
+	 * \param slot_size maximal image size in bytes
+	 */
+	bool create(const std::string & name, unsigned int slots, unsigned int slot_size);
+
+	/*!
+	 * Unmaps and removes shared memory object. Attached readers keep their mapping.
+	 */
+	void destroy();
+
+	bool isOpen() const { return m_header != NULL; }
+
+	/*!
+	 * Copies frame to next slot, never blocks.
+	 * \returns false if image does not fit in slot
+	 */
+	bool publish(const void * data, unsigned int width, unsigned int height, unsigned int type,
+			unsigned int step, const FrameInfo & info);
+
+private:
+	std::string m_name;
+	SharedRingHeader * m_header;
+	size_t m_size;
+
+	SharedFrameWriter(const SharedFrameWriter &);
+	SharedFrameWriter & operator=(const SharedFrameWriter &);
+};
+
+/*!
+ * \class SharedFrameReader
+ * \brief Reads frames published by SharedFrameWriter.
+ */
+class SharedFrameReader {
+public:
+	/// Result of read
+	enum Status {
+		/// Frame was read
+		Ok,
+		/// No new frame since last read (frames lost while searching are still counted in lost())
+		NoData,
+		/// Frame was read, but reader was too slow and some frames before it were lost
+		Overrun,
+		/// Producer closed or recreated the ring, reader has to attach again
+		Closed
+	};
+
+	SharedFrameReader();
+
+	~SharedFrameReader();
+
+	/*!
+	 * Attaches to ring, reading starts from next published frame.
+	 */
+	bool attach(const std::string & name);
+
+	void detach();
+
+	bool isAttached() const { return m_header != NULL; }
+
+	/*!
+	 * Reads oldest frame not yet read which is still available in ring.
+	 * Detaches and returns Closed once producer destroyed the ring.
+	 * \param frame filled with frame data, buffer is reused between calls
+	 */
+	Status read(SharedFrame & frame);
+
+	/// Number of frames lost due to overruns
+	uint64_t lost() const { return m_lost; }
+
+private:
+	SharedRingHeader * m_header;
+	size_t m_size;
+
+	/// Sequence number of next frame to read
+	uint64_t m_next;
+
+	uint64_t m_lost;
+
+	SharedFrameReader(const SharedFrameReader &);
+	SharedFrameReader & operator=(const SharedFrameReader &);
+};
+
+}//: namespace Types
+
+#endif /* SHAREDFRAMERING_HPP_ */